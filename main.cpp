@@ -18,16 +18,22 @@
 #include "raylib.h"
 #include "raymath.h"
 #include <iostream>
+#include <algorithm>
+#include <climits>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 
 #if defined(PLATFORM_WEB)
 #include <emscripten/emscripten.h>
 #define ASSETPATH "resources/"
 #else
+#include <chrono>
+#include <future>
 #define ASSETPATH "../resources/"
 #endif
 
-#define MAXENEMIES 30
 #define MAXBLOCKSIZE 6
 #define MAXHOLDING 5
 #define MAXPARTICLES 10
@@ -55,13 +61,27 @@ typedef struct ParticleBurst {
 } ParticleBurst;
 
 
+// Stable reference to an enemy. Only valid while the slot's generation matches.
+typedef struct EnemyHandle {
+    int slot;
+    int generation;
+} EnemyHandle;
+
+// Live enemies are packed at [0, EnemyCount()) so loops never touch dead ones.
+// Slots map handles to dense indices and survive swap-removes.
 struct Enemies {
-    Vector2 position[MAXENEMIES];
-    Vector2 target[MAXENEMIES];
-    float waitTime[MAXENEMIES];
-    bool enabled [MAXENEMIES];
+    std::vector<Vector2> position;
+    std::vector<Vector2> target;
+    std::vector<float> waitTime;
+    std::vector<int> slot;          // dense index -> slot
+
+    std::vector<int> denseIndex;    // slot -> dense index, -1 when free
+    std::vector<int> generation;    // slot -> generation
+    std::vector<int> freeSlots;
+    int slotsUsed;
+
     Texture2D texture;
-} enemies, e;
+} enemies;
 
 
 struct BlockPlacer {
@@ -72,6 +92,17 @@ struct BlockPlacer {
 
 ParticleBurst ParticleSystem[20];
 
+// Best placement found by the hint search. rotations is how many presses of
+// the rotate button turn the held block into this shape.
+typedef struct Hint {
+    bool valid;
+    int item;
+    int rotations;
+    Vector2Int position;
+    Block block;
+    float score;
+} Hint;
+
 //----------------------------------------------------------------------------------
 // Global Variables Definition
 //----------------------------------------------------------------------------------
@@ -86,6 +117,7 @@ const int rows = 7;
 
 int grid[rows][columns];
 
+int MaxEnemies = 30;
 int EnemySpawnDelay = 5;
 const int BlockSpawnDelay = 3;
 
@@ -118,6 +150,28 @@ int state = 0;
 Vector2 TouchPosition;
 int currentGesture;
 
+bool ShowHints = false;
+bool HintsOnThread = false;     // Opt-in, the search only takes microseconds
+const float HintKillWeight = 10.0f;
+const float HintPathWeight = 1.0f;
+
+// Everything the hint search reads, copied out so it can run off the main thread.
+struct HintInput {
+    bool occupied[rows][columns];
+    int enemyCount[rows][columns];
+    Block inventory[MAXHOLDING];
+    int held;
+};
+
+HintInput LastHintInput = {};
+Hint CurrentHint;
+bool HintDirty = true;
+
+#if !defined(PLATFORM_WEB)
+std::future<Hint> HintJob;
+HintInput HintJobInput = {};    // What the running job was started from
+#endif
+
 //----------------------------------------------------------------------------------
 // Module functions declaration
 //----------------------------------------------------------------------------------
@@ -127,6 +181,12 @@ Vector2 GridToPosition(Vector2Int pos);
 bool isInGrid(Vector2 pos);
 void DrawEnemies();
 void UpdateEnemies(float dt);
+void ResetEnemies();
+void SetMaxEnemies(int cap);
+int EnemyCount();
+void SpawnEnemy();
+EnemyHandle GetEnemyHandle(int index);
+bool IsEnemyAlive(EnemyHandle handle);
 void UpdateBlocks(float dt);
 void DrawBlocks();
 void ManageInput();
@@ -140,6 +200,8 @@ void DrawFolderFronts();
 void CreateEnemyParticles(Vector2 origin);
 void UpdateParticleSystems(float dt);
 void DrawParticleSystems();
+void UpdateHints();
+void DrawHint();
 
 // Global Variables
 
@@ -147,7 +209,7 @@ void DrawParticleSystems();
 //------------------------------------------------------------------------------------
 // Program main entry point
 //------------------------------------------------------------------------------------
-int main(void)
+int main(int argc, char **argv)
 {
     // Initialization
     //--------------------------------------------------------------------------------------
@@ -155,7 +217,19 @@ int main(void)
     InitAudioDevice();
 
     enemies.texture = LoadTexture(ASSETPATH "gj.png");
-    e.texture = enemies.texture;
+    // Optional first argument overrides the enemy cap.
+    int enemyCap = MaxEnemies;
+    if (argc > 1) {
+        char *end;
+        long cap = std::strtol(argv[1], &end, 10);
+        if (end != argv[1] && *end == '\0' && cap > 0 && cap <= INT_MAX) {
+            enemyCap = (int)cap;
+        } else {
+            TraceLog(LOG_WARNING, "Ignoring enemy cap \"%s\", keeping %d", argv[1], MaxEnemies);
+        }
+    }
+    SetMaxEnemies(enemyCap);
+    ResetEnemies();
     Background = LoadTexture(ASSETPATH "fullwindow.png");
     FolderBack = LoadTexture(ASSETPATH "folde-back-paper.png");
     FolderFront = LoadTexture(ASSETPATH "folder-front.png");
@@ -204,7 +278,7 @@ void RestartGame() {
 
 
     EnemySpawnDelay = 5;
-    enemies = e;
+    ResetEnemies();
     BlockPlacer = b;
 
     BlockPlacer.inventorySpot = 0;
@@ -237,6 +311,7 @@ void UpdateDrawFrame(void)
         UpdateBlocks(dt);
         UpdateGrid(dt);
         UpdateParticleSystems(dt);
+        UpdateHints();
 
         //----------------------------------------------------------------------------------
 
@@ -256,6 +331,7 @@ void UpdateDrawFrame(void)
         DrawTexture(PressedButton, 866, 16, WHITE);
         DrawBlocks();
         DisplayBrokenTiles();
+        DrawHint();
         ShowSelection();
         DrawParticleSystems();
         auto sScore = std::to_string(score);
@@ -320,13 +396,17 @@ bool DoesBlockFit(Block block, Vector2Int position) {
     return true;
 }
 
+void RotateBlock(Block &block) {
+    for (Vector2Int &content : block.contents) {
+        int x = content.x;
+        content.x = -content.y;
+        content.y = x;
+    }
+}
+
 void RotateBlocks() {
     for (Block &block : BlockPlacer.inventory) {
-        for (Vector2Int &content : block.contents) {
-            int x = content.x;
-            content.x = -content.y;
-            content.y = x;
-        }
+        RotateBlock(block);
     }
 
     PlaySound(Rotate);
@@ -337,6 +417,9 @@ void ManageInput() {
     currentGesture = GetGestureDetected();
     auto touchPosition = GetTouchPosition(0);
 
+    if (IsKeyPressed(KEY_H)) ShowHints = !ShowHints;
+    if (IsKeyPressed(KEY_T)) HintsOnThread = !HintsOnThread;
+
     if (currentGesture == GESTURE_TAP || currentGesture == GESTURE_DOUBLETAP) {
         Rectangle touchArea = {866, 16, 20, 20};
         if (CheckCollisionPointRec(touchPosition, touchArea) && BlockPlacer.selected < 0) {
@@ -449,10 +532,28 @@ void DrawParticleSystems() {
 }
 
 void KillEnemy(int index) {
-    if (!enemies.enabled[index]) return;
-    enemies.enabled[index] = false;
+    if (index < 0 || index >= EnemyCount()) return;
     CreateEnemyParticles(enemies.position[index]);
     score += 1;
+
+    // Swap the last live enemy into the hole so the dense range stays packed.
+    int last = EnemyCount() - 1;
+    int deadSlot = enemies.slot[index];
+
+    enemies.position[index] = enemies.position[last];
+    enemies.target[index] = enemies.target[last];
+    enemies.waitTime[index] = enemies.waitTime[last];
+    enemies.slot[index] = enemies.slot[last];
+    enemies.denseIndex[enemies.slot[index]] = index;
+
+    enemies.position.pop_back();
+    enemies.target.pop_back();
+    enemies.waitTime.pop_back();
+    enemies.slot.pop_back();
+
+    enemies.denseIndex[deadSlot] = -1;
+    enemies.generation[deadSlot]++;
+    enemies.freeSlots.push_back(deadSlot);
 }
 
 void PlaceBlock(Block block, Vector2Int position, bool doesFit) {
@@ -460,7 +561,8 @@ void PlaceBlock(Block block, Vector2Int position, bool doesFit) {
         for (Vector2Int &content: block.contents) {
             grid[position.y + content.y][position.x + content.x] = 1000;
 
-            for (int i=0;i<MAXENEMIES;i++) {
+            // Walk backwards so a swap-remove only moves already checked enemies.
+            for (int i=EnemyCount()-1;i>=0;i--) {
                 auto tile = PositionToGrid(enemies.position[i]);
                 if (isInGrid(enemies.position[i])) {
                     if (tile.x == position.x + content.x && tile.y == position.y + content.y) {
@@ -526,27 +628,86 @@ bool isInGrid(Vector2 position) {
 }
 
 
-void SpawnEnemy(int index) {
+void ResetEnemies() {
+    // Bumping generations on reuse keeps stale handles invalid, so this stays O(1).
+    enemies.position.clear();
+    enemies.target.clear();
+    enemies.waitTime.clear();
+    enemies.slot.clear();
+    enemies.freeSlots.clear();
+    enemies.slotsUsed = 0;
+}
 
-    int side = GetRandomValue(1, 4);
+void SetMaxEnemies(int cap) {
+    if (cap < 1) {
+        TraceLog(LOG_WARNING, "Ignoring enemy cap %d, keeping %d", cap, MaxEnemies);
+        cap = MaxEnemies;
+    }
+
+    // Live enemies over a lowered cap are left alone; spawning just waits.
+    MaxEnemies = cap;
+    enemies.position.reserve(MaxEnemies);
+    enemies.target.reserve(MaxEnemies);
+    enemies.waitTime.reserve(MaxEnemies);
+    enemies.slot.reserve(MaxEnemies);
+}
+
+int EnemyCount() {
+    return (int)enemies.position.size();
+}
+
+EnemyHandle GetEnemyHandle(int index) {
+    int slot = enemies.slot[index];
+    return {slot, enemies.generation[slot]};
+}
+
+bool IsEnemyAlive(EnemyHandle handle) {
+    if (handle.slot < 0 || handle.slot >= enemies.slotsUsed) return false;
+    if (enemies.generation[handle.slot] != handle.generation) return false;
+    return enemies.denseIndex[handle.slot] >= 0;
+}
+
+void SpawnEnemy() {
+    if (EnemyCount() >= MaxEnemies) return;
+
+    int slot;
+    if (!enemies.freeSlots.empty()) {
+        slot = enemies.freeSlots.back();
+        enemies.freeSlots.pop_back();
+    } else {
+        slot = enemies.slotsUsed++;
+        if (slot >= (int)enemies.generation.size()) {
+            enemies.generation.push_back(0);
+            enemies.denseIndex.push_back(-1);
+        } else {
+            enemies.generation[slot]++;
+        }
+    }
 
-    enemies.waitTime[index] = 0;
+    int side = GetRandomValue(1, 4);
+    Vector2 position;
+    Vector2 target;
 
     if (side % 2 == 0) {
 
-        enemies.target[index] = Vector2Add(GridToPosition({((side-1)/2 > 0) ? columns - 1 : 0, GetRandomValue(0,rows - 1)}), {24,34});
+        target = Vector2Add(GridToPosition({((side-1)/2 > 0) ? columns - 1 : 0, GetRandomValue(0,rows - 1)}), {24,34});
 
-        enemies.position[index].y = enemies.target[index].y;
-        enemies.position[index].x = enemies.target[index].x - (((side-1)/2 > 0) ? -48.0f : 48.0f);
+        position.y = target.y;
+        position.x = target.x - (((side-1)/2 > 0) ? -48.0f : 48.0f);
 
     } else {
 
-        enemies.target[index] = Vector2Add(GridToPosition({GetRandomValue(0,columns - 1), ((side-1)/2 > 0) ? rows - 1 : 0}), {24,34});
+        target = Vector2Add(GridToPosition({GetRandomValue(0,columns - 1), ((side-1)/2 > 0) ? rows - 1 : 0}), {24,34});
 
-        enemies.position[index].y = enemies.target[index].y -(((side-1)/2 > 0) ? -48.0f : 48.0f);
-        enemies.position[index].x = enemies.target[index].x;
+        position.y = target.y -(((side-1)/2 > 0) ? -48.0f : 48.0f);
+        position.x = target.x;
     }
-    enemies.enabled[index] = true;
+
+    enemies.denseIndex[slot] = EnemyCount();
+    enemies.position.push_back(position);
+    enemies.target.push_back(target);
+    enemies.waitTime.push_back(0);
+    enemies.slot.push_back(slot);
 }
 
 void GameOver() {
@@ -589,15 +750,7 @@ void UpdateEnemies(float dt) {
 
     }
 
-    for (int i=0;i<MAXENEMIES;i++) {
-        if (!enemies.enabled[i]) {
-            if (spawnEnemy) {
-                SpawnEnemy(i);
-                spawnEnemy = false;
-            }
-            continue;
-        }
-
+    for (int i=0;i<EnemyCount();i++) {
         if (enemies.waitTime[i] > 0) {
             enemies.waitTime[i] -= dt;
             continue;
@@ -609,16 +762,22 @@ void UpdateEnemies(float dt) {
         if (Vector2LengthSqr(moveVector) >= Vector2LengthSqr(distanceVector)) {
             enemies.position[i] = enemies.target[i];
             enemies.waitTime[i] = EnemyHideTime;
-            enemies.target[i] = GetNextMoveTile(i);
+            auto handle = GetEnemyHandle(i);
+            auto next = GetNextMoveTile(i);
+
+            // Reaching the final tile restarts the game and empties the store.
+            if (!IsEnemyAlive(handle)) break;
+            enemies.target[i] = next;
         }
 
         enemies.position[i] = Vector2Add(enemies.position[i], moveVector);
     }
+
+    if (spawnEnemy) SpawnEnemy();
 }
 
 void DrawEnemies() {
-    for (int i=0;i<MAXENEMIES;i++) {
-        if (!enemies.enabled[i]) continue;
+    for (int i=0;i<EnemyCount();i++) {
         DrawTexturePro(enemies.texture, {0, 0, (float)enemies.texture.width, (float)enemies.texture.height}, {enemies.position[i].x, enemies.position[i].y, (float)enemies.texture.width, (float)enemies.texture.height}, {enemies.texture.width / 2.0f, enemies.texture.height / 2.0f}, 0, WHITE);
     }
 }
@@ -677,3 +836,220 @@ void DrawBlocks() {
 
 
 
+
+void GatherHintInput(HintInput &input) {
+    std::memset(input.enemyCount, 0, sizeof(input.enemyCount));
+
+    for (int i=0;i<rows;i++) {
+        for (int j=0;j<columns;j++) {
+            input.occupied[i][j] = grid[i][j] != 0;
+        }
+    }
+
+    // Same tile test PlaceBlock uses to decide who gets squashed.
+    for (int i=0;i<EnemyCount();i++) {
+        if (!isInGrid(enemies.position[i])) continue;
+        auto tile = PositionToGrid(enemies.position[i]);
+        if (tile.x < 0 || tile.x >= columns || tile.y < 0 || tile.y >= rows) continue;
+        input.enemyCount[tile.y][tile.x]++;
+    }
+
+    input.held = BlockPlacer.inventorySpot;
+    for (int i=0;i<input.held;i++) {
+        input.inventory[i] = BlockPlacer.inventory[i];
+    }
+}
+
+bool SameBlock(const Block &a, const Block &b) {
+    if (a.count != b.count) return false;
+    for (int i=0;i<MAXBLOCKSIZE;i++) {
+        if (a.contents[i].x != b.contents[i].x || a.contents[i].y != b.contents[i].y) return false;
+    }
+    return true;
+}
+
+bool SameInventory(const HintInput &input) {
+    if (input.held != BlockPlacer.inventorySpot) return false;
+    for (int i=0;i<input.held;i++) {
+        if (!SameBlock(input.inventory[i], BlockPlacer.inventory[i])) return false;
+    }
+    return true;
+}
+
+// Field by field, since the struct has padding that copies don't have to keep.
+bool SameHintInput(const HintInput &a, const HintInput &b) {
+    if (std::memcmp(a.occupied, b.occupied, sizeof(a.occupied)) != 0) return false;
+    if (std::memcmp(a.enemyCount, b.enemyCount, sizeof(a.enemyCount)) != 0) return false;
+    if (a.held != b.held) return false;
+    for (int i=0;i<a.held;i++) {
+        if (!SameBlock(a.inventory[i], b.inventory[i])) return false;
+    }
+    return true;
+}
+
+// Chance that an enemy standing on each tile later walks through it, following
+// the same coin flip GetNextMoveTile makes between closing x and closing y.
+void AccumulatePathWeights(const HintInput &input, float weight[rows][columns]) {
+    float chance[rows][columns];
+
+    for (int ey=0;ey<rows;ey++) {
+        for (int ex=0;ex<columns;ex++) {
+            int count = input.enemyCount[ey][ex];
+            if (count == 0) continue;
+
+            int stepX = (FinalTile.x > ex) ? 1 : -1;
+            int stepY = (FinalTile.y > ey) ? 1 : -1;
+            int spanX = std::abs(FinalTile.x - ex);
+            int spanY = std::abs(FinalTile.y - ey);
+
+            // Tiles are visited in path order, so every tile's chance is final
+            // before it is pushed on to its neighbours.
+            for (int a=0;a<=spanX;a++) {
+                for (int b=0;b<=spanY;b++) {
+                    chance[ey + b*stepY][ex + a*stepX] = (a == 0 && b == 0) ? 1.0f : 0.0f;
+                }
+            }
+
+            for (int a=0;a<=spanX;a++) {
+                for (int b=0;b<=spanY;b++) {
+                    int x = ex + a*stepX;
+                    int y = ey + b*stepY;
+                    float here = chance[y][x];
+
+                    if (a == spanX && b == spanY) continue;
+
+                    // The tile the enemy is already on can't be blocked any more.
+                    if (a != 0 || b != 0) weight[y][x] += here * (float)count;
+
+                    if (b == spanY) {
+                        chance[y][x + stepX] += here;
+                    } else if (a == spanX) {
+                        chance[y + stepY][x] += here;
+                    } else {
+                        chance[y][x + stepX] += here * 0.5f;
+                        chance[y + stepY][x] += here * 0.5f;
+                    }
+                }
+            }
+        }
+    }
+}
+
+Hint FindBestPlacement(const HintInput &input) {
+    Hint best = {};
+    best.valid = false;
+
+    // Fold kills and path blocking into one value per tile so scoring a
+    // placement is just a handful of lookups.
+    float pathWeight[rows][columns] = {};
+    AccumulatePathWeights(input, pathWeight);
+
+    float value[rows][columns];
+    for (int i=0;i<rows;i++) {
+        for (int j=0;j<columns;j++) {
+            value[i][j] = input.enemyCount[i][j] * HintKillWeight + pathWeight[i][j] * HintPathWeight;
+        }
+    }
+
+    for (int item=0;item<input.held;item++) {
+        Block block = input.inventory[item];
+
+        for (int rotation=0;rotation<4;rotation++) {
+            int minX = 0, maxX = 0, minY = 0, maxY = 0;
+            for (int c=0;c<block.count;c++) {
+                minX = std::min(minX, block.contents[c].x);
+                maxX = std::max(maxX, block.contents[c].x);
+                minY = std::min(minY, block.contents[c].y);
+                maxY = std::max(maxY, block.contents[c].y);
+            }
+
+            // Only offsets that keep the whole block on the board.
+            for (int y=-minY;y<rows-maxY;y++) {
+                for (int x=-minX;x<columns-maxX;x++) {
+                    float score = 0;
+                    bool fits = true;
+
+                    for (int c=0;c<block.count;c++) {
+                        int tx = x + block.contents[c].x;
+                        int ty = y + block.contents[c].y;
+                        // Covering the Command tile doesn't stop an enemy that arrives.
+                        if (input.occupied[ty][tx] || (tx == FinalTile.x && ty == FinalTile.y)) {
+                            fits = false;
+                            break;
+                        }
+                        score += value[ty][tx];
+                    }
+
+                    if (!fits || score <= 0) continue;
+                    if (best.valid && score <= best.score) continue;
+
+                    best.valid = true;
+                    best.item = item;
+                    best.rotations = rotation;
+                    best.position = {x, y};
+                    best.block = block;
+                    best.score = score;
+                }
+            }
+
+            RotateBlock(block);
+        }
+    }
+
+    return best;
+}
+
+void UpdateHints() {
+    if (!ShowHints) {
+        HintDirty = true;
+        return;
+    }
+
+    HintInput input = {};
+    GatherHintInput(input);
+
+    // The grid ticks down every frame but the search only cares whether
+    // tiles are free, so most frames nothing it reads has moved.
+    if (!HintDirty && SameHintInput(input, LastHintInput)) return;
+
+#if !defined(PLATFORM_WEB)
+    if (HintsOnThread) {
+        if (HintJob.valid()) {
+            if (HintJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+            Hint result = HintJob.get();
+            if (SameHintInput(HintJobInput, input)) {
+                CurrentHint = result;
+                LastHintInput = input;
+                HintDirty = false;
+                return;
+            }
+        }
+
+        // Stale or missing answer. DrawHint hides the old hint if the inventory moved on.
+        HintJobInput = input;
+        HintJob = std::async(std::launch::async, [in = input] { return FindBestPlacement(in); });
+        return;
+    }
+#endif
+
+    CurrentHint = FindBestPlacement(input);
+    LastHintInput = input;
+    HintDirty = false;
+}
+
+void DrawHint() {
+    if (!ShowHints || !CurrentHint.valid || BlockPlacer.selected >= 0) return;
+
+    // While the worker catches up, item and rotations only hold for the
+    // inventory the hint was computed from.
+    if (!SameInventory(LastHintInput)) return;
+    if (!DoesBlockFit(CurrentHint.block, CurrentHint.position)) return;
+
+    DrawBlockOnGrid(CurrentHint.block, CurrentHint.position, true);
+    DrawBlock(BlockPlacer.inventory[CurrentHint.item], {802.0f - 12, 96 + CurrentHint.item*86.0f}, 24, YELLOW);
+
+    if (CurrentHint.rotations > 0) {
+        DrawText(std::to_string(CurrentHint.rotations).c_str(), 850, 18, 20, YELLOW);
+    }
+}